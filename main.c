@@ -4,10 +4,16 @@
 #include <ctype.h>
 #include <stddef.h>
 #include <time.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // constants
 // max number of arguments user can provide
-const int maxArgumentsLength = 6;
+const int maxArgumentsLength = 12;
 // letters constants
 const int defaultLettersLength = 7;
 const int defaultMinLettersLength = 3;
@@ -23,6 +29,7 @@ const int shortLettersLengthStatus = 11;
 const int invalidDictStatus = 6;
 const int exitGameStatus = 0;
 const int exitGameNoGuessStatus = 18;
+const int rackTableErrorStatus = 20;
 // used in declaring variables
 // max length for an argument the user provides
 const int maxArgValLength = 100;
@@ -34,22 +41,42 @@ const int initialWordsSize = 100;
 const int initialOneWordSize = 3;
 // extra score added when user's guess uses all the letters provided
 const int bonusScore = 10;
+// alphabet constants
+// max number of letters in an alphabet, leaving symbol 0 to end a word and
+// one symbol for unknown letters
+const int maxAlphabetSize = 254;
+// letter count arrays are padded to a multiple of this many entries
+const int countsAlignment = 16;
+// rack table constants
+// number of letters in every rack stored in the rack table
+const int tableRackLength = 7;
+// number of bits used by a single symbol inside a signature
+const int signatureSymbolBits = 8;
+// number of worker threads used if the core count can't be determined
+const int defaultNumThreads = 4;
+// max number of random racks tried before settling for the last one
+const int maxRackRerolls = 1000;
+// max number of best words that can be revealed after the game
+const int maxTopWords = 1000;
+// identifies a rack table file
+const char rackTableMagic[4] = {'U', 'R', 'S', 'T'};
 
 /* Given the pair of arguments and corresponding value, assign the value to
  * the corresponding variables provided as arguments.
  */
 int assign_values(char* firstEle, char* secondEle, int* minLength,
-        char* letters, char* dict)
+        char** letters, char* dict, char** table, char** buildTable,
+        int* topK)
 {
     if (strcmp(firstEle, "--min-length") == 0) {
         // check if the length of the value for min length is 1 and isn't
         // a letter
-        if (!(strlen(secondEle) == 1 && !isalpha(secondEle[0]))) {
+        if (!(strlen(secondEle) == 1 && !isalpha((unsigned char)secondEle[0]))) {
             return 1;
         }
         *minLength = atoi(secondEle);
     } else if (strcmp(firstEle, "--letters") == 0) {
-        strcpy(letters, secondEle);
+        *letters = secondEle;
     } else if (strcmp(firstEle, "--dict") == 0) {
         // check if size of new dict path is longer than the initial size
         if ((int)strlen(secondEle) > initialDictSize) {
@@ -57,6 +84,19 @@ int assign_values(char* firstEle, char* secondEle, int* minLength,
         }
 
         strcpy(dict, secondEle);
+    } else if (strcmp(firstEle, "--table") == 0) {
+        *table = secondEle;
+    } else if (strcmp(firstEle, "--build-table") == 0) {
+        *buildTable = secondEle;
+    } else if (strcmp(firstEle, "--top") == 0) {
+        // check the value is a number between 1 and maxTopWords
+        char* end;
+        long value = strtol(secondEle, &end, 10);
+        if (end == secondEle || *end != '\0' || value < 1
+                || value > maxTopWords) {
+            return 1;
+        }
+        *topK = (int)value;
     }
     return 0;
 }
@@ -76,8 +116,8 @@ int check_duplicate_arguments(
 
 /* Check if the arguments are valid, with correct argument name provided,
  * no duplicate argument names and assign the default values. */
-int check_arguments(
-        int argc, char** argv, int* minLength, char* letters, char* dict)
+int check_arguments(int argc, char** argv, int* minLength, char** letters,
+        char* dict, char** table, char** buildTable, int* topK)
 {
     // default value for the arugments
     *minLength = defaultMinLettersLength;
@@ -101,7 +141,10 @@ int check_arguments(
         // check the first element of each pair of arguments are valid
         if (!(strcmp(firstEle, "--letters") == 0
                     || strcmp(firstEle, "--dict") == 0
-                    || strcmp(firstEle, "--min-length") == 0)) {
+                    || strcmp(firstEle, "--min-length") == 0
+                    || strcmp(firstEle, "--table") == 0
+                    || strcmp(firstEle, "--build-table") == 0
+                    || strcmp(firstEle, "--top") == 0)) {
             return 1;
         }
 
@@ -115,7 +158,9 @@ int check_arguments(
 
         // store the value of the second element in corresponding variables
         // check length provided is a single digit number
-        if (assign_values(firstEle, secondEle, minLength, letters, dict) == 1) {
+        if (assign_values(firstEle, secondEle, minLength, letters, dict, table,
+                    buildTable, topK)
+                == 1) {
             return 1;
         }
     }
@@ -130,21 +175,367 @@ int print_usage_err()
 {
     fprintf(stderr,
             "Usage: unscramble [--min-length numchars] [--dict file] "
-            "[--letters chars]\n");
+            "[--letters chars] [--table file] [--build-table file] "
+            "[--top count]\n");
     return usageErrorStatus;
 }
 
-/* Checks if the provided string contain only letters from (a-z and A-Z). */
+/* Decode the UTF-8 character at the start of text into codePoint.
+ * Returns the number of bytes used, or 0 if the bytes aren't valid UTF-8.
+ */
+int decode_utf8(const char* text, uint32_t* codePoint)
+{
+    const unsigned char* bytes = (const unsigned char*)text;
+    int length;
+    uint32_t value;
+    uint32_t minValue;
+    if (bytes[0] < 0x80) {
+        *codePoint = bytes[0];
+        return 1;
+    } else if ((bytes[0] & 0xE0) == 0xC0) {
+        length = 2;
+        value = bytes[0] & 0x1F;
+        minValue = 0x80;
+    } else if ((bytes[0] & 0xF0) == 0xE0) {
+        length = 3;
+        value = bytes[0] & 0x0F;
+        minValue = 0x800;
+    } else if ((bytes[0] & 0xF8) == 0xF0) {
+        length = 4;
+        value = bytes[0] & 0x07;
+        minValue = 0x10000;
+    } else {
+        return 0;
+    }
+
+    for (int i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        value = (value << 6) | (bytes[i] & 0x3F);
+    }
+    // reject overlong encodings, surrogates and values past the last
+    // code point
+    if (value < minValue || (value >= 0xD800 && value <= 0xDFFF)
+            || value > 0x10FFFF) {
+        return 0;
+    }
+    *codePoint = value;
+    return length;
+}
+
+/* Write the UTF-8 encoding of the code point to text, which must have room
+ * for 4 bytes. Returns the number of bytes written.
+ */
+int encode_utf8(uint32_t codePoint, char* text)
+{
+    if (codePoint < 0x80) {
+        text[0] = codePoint;
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        text[0] = 0xC0 | (codePoint >> 6);
+        text[1] = 0x80 | (codePoint & 0x3F);
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        text[0] = 0xE0 | (codePoint >> 12);
+        text[1] = 0x80 | ((codePoint >> 6) & 0x3F);
+        text[2] = 0x80 | (codePoint & 0x3F);
+        return 3;
+    }
+    text[0] = 0xF0 | (codePoint >> 18);
+    text[1] = 0x80 | ((codePoint >> 12) & 0x3F);
+    text[2] = 0x80 | ((codePoint >> 6) & 0x3F);
+    text[3] = 0x80 | (codePoint & 0x3F);
+    return 4;
+}
+
+// A range of code points that are all letters
+typedef struct LetterRange {
+    uint32_t first;
+    uint32_t last;
+} LetterRange;
+
+// the letters of the Latin (with IPA), Greek, Cyrillic, Armenian, Hebrew,
+// Arabic, Georgian and kana scripts, in code point order. Digits,
+// punctuation and combining marks such as Hebrew and Arabic vowel points
+// are left out, so words using them are skipped.
+const LetterRange letterRanges[] = {{'A', 'Z'}, {'a', 'z'}, {0xC0, 0xD6},
+        {0xD8, 0xF6}, {0xF8, 0x2AF}, {0x386, 0x386}, {0x388, 0x38A},
+        {0x38C, 0x38C}, {0x38E, 0x3A1}, {0x3A3, 0x3CE}, {0x400, 0x481},
+        {0x48A, 0x52F}, {0x531, 0x556}, {0x561, 0x587}, {0x5D0, 0x5EA},
+        {0x620, 0x63F}, {0x641, 0x64A}, {0x66E, 0x66F}, {0x671, 0x6D3},
+        {0x6D5, 0x6D5}, {0x10D0, 0x10FA}, {0x10FD, 0x10FF},
+        {0x1E00, 0x1EFF}, {0x3041, 0x3096}, {0x30A1, 0x30FA}};
+
+/* Check if the code point is a letter of one of the scripts in
+ * letterRanges.
+ */
+int is_letter_code_point(uint32_t codePoint)
+{
+    int low = 0;
+    int high = sizeof(letterRanges) / sizeof(LetterRange) - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (codePoint < letterRanges[middle].first) {
+            high = middle - 1;
+        } else if (codePoint > letterRanges[middle].last) {
+            low = middle + 1;
+        } else {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// A lowercase letter whose capital isn't next to it
+typedef struct CasePair {
+    uint32_t lower;
+    uint32_t upper;
+} CasePair;
+
+// the irregular letters of Latin Extended-B and the IPA letters used by
+// African alphabets, in code point order
+const CasePair irregularCases[] = {{0x180, 0x243}, {0x183, 0x182},
+        {0x185, 0x184}, {0x188, 0x187}, {0x18C, 0x18B}, {0x192, 0x191},
+        {0x195, 0x1F6}, {0x199, 0x198}, {0x19A, 0x23D}, {0x19E, 0x220},
+        {0x1A1, 0x1A0}, {0x1A3, 0x1A2}, {0x1A5, 0x1A4}, {0x1A8, 0x1A7},
+        {0x1AD, 0x1AC}, {0x1B0, 0x1AF}, {0x1B4, 0x1B3}, {0x1B6, 0x1B5},
+        {0x1B9, 0x1B8}, {0x1BD, 0x1BC}, {0x1BF, 0x1F7}, {0x1DD, 0x18E},
+        {0x1F5, 0x1F4}, {0x23C, 0x23B}, {0x242, 0x241}, {0x253, 0x181},
+        {0x254, 0x186}, {0x256, 0x189}, {0x257, 0x18A}, {0x259, 0x18F},
+        {0x25B, 0x190}, {0x260, 0x193}, {0x263, 0x194}, {0x268, 0x197},
+        {0x269, 0x196}, {0x26F, 0x19C}, {0x272, 0x19D}, {0x275, 0x19F},
+        {0x280, 0x1A6}, {0x283, 0x1A9}, {0x288, 0x1AE}, {0x289, 0x244},
+        {0x28A, 0x1B1}, {0x28B, 0x1B2}, {0x28C, 0x245}, {0x292, 0x1B7}};
+
+/* Return the uppercase version of the code point, independent of the locale,
+ * for Latin letters up to Latin Extended-B and Latin Extended Additional,
+ * the IPA letters used by African alphabets, modern Greek, Cyrillic and Armenian. Other code points, including polytonic
+ * Greek, are returned unchanged.
+ */
+uint32_t to_upper_code_point(uint32_t codePoint)
+{
+    if (codePoint >= 'a' && codePoint <= 'z') {
+        return codePoint - ('a' - 'A');
+    }
+    if (codePoint >= 0xE0 && codePoint <= 0xFE && codePoint != 0xF7) {
+        return codePoint - 0x20;
+    }
+    if (codePoint == 0xFF) {
+        return 0x178;
+    }
+    // the case of the Turkish dotted capital I and dotless i depends on
+    // the language, so they are left alone rather than merged with I or i
+    if (codePoint == 0x130 || codePoint == 0x131) {
+        return codePoint;
+    }
+    // Latin Extended-A pairs the uppercase letter with the lowercase one
+    // after it, with the pairs shifted by one between 0x139 and 0x148 and
+    // after 0x179
+    if ((codePoint >= 0x100 && codePoint <= 0x137)
+            || (codePoint >= 0x14A && codePoint <= 0x177)) {
+        return codePoint & ~(uint32_t)1;
+    }
+    if (((codePoint >= 0x139 && codePoint <= 0x148)
+                || (codePoint >= 0x179 && codePoint <= 0x17E))
+            && codePoint % 2 == 0) {
+        return codePoint - 1;
+    }
+    if (codePoint >= 0x180 && codePoint <= 0x292) {
+        for (size_t i = 0; i < sizeof(irregularCases) / sizeof(CasePair);
+                i++) {
+            if (irregularCases[i].lower == codePoint) {
+                return irregularCases[i].upper;
+            }
+        }
+    }
+    // Latin Extended-B, where the digraphs DŽ, LJ, NJ and DZ have a title
+    // case form between the upper and lowercase ones
+    if ((codePoint >= 0x1C4 && codePoint <= 0x1CC)
+            || (codePoint >= 0x1F1 && codePoint <= 0x1F3)) {
+        return codePoint - (codePoint - 0x1C4) % 3;
+    }
+    if (codePoint >= 0x1CD && codePoint <= 0x1DC && codePoint % 2 == 0) {
+        return codePoint - 1;
+    }
+    if ((codePoint >= 0x1DE && codePoint <= 0x1EF)
+            || (codePoint >= 0x1F8 && codePoint <= 0x21F)
+            || (codePoint >= 0x222 && codePoint <= 0x233)
+            || (codePoint >= 0x246 && codePoint <= 0x24F)) {
+        return codePoint & ~(uint32_t)1;
+    }
+    // Latin Extended Additional, used by Vietnamese among others
+    if ((codePoint >= 0x1E00 && codePoint <= 0x1E95)
+            || (codePoint >= 0x1EA0 && codePoint <= 0x1EFF)) {
+        return codePoint & ~(uint32_t)1;
+    }
+    // Greek, where final sigma becomes sigma and the accented letters have
+    // their capitals before the plain ones
+    if (codePoint == 0x3C2) {
+        return 0x3A3;
+    }
+    if (codePoint >= 0x3B1 && codePoint <= 0x3CB) {
+        return codePoint - 0x20;
+    }
+    if (codePoint == 0x3AC) {
+        return 0x386;
+    }
+    if (codePoint >= 0x3AD && codePoint <= 0x3AF) {
+        return codePoint - 0x25;
+    }
+    if (codePoint == 0x3CC) {
+        return 0x38C;
+    }
+    if (codePoint >= 0x3CD && codePoint <= 0x3CE) {
+        return codePoint - 0x3F;
+    }
+    // Cyrillic, with the historic and non-Russian letters paired from 0x460
+    if (codePoint >= 0x430 && codePoint <= 0x44F) {
+        return codePoint - 0x20;
+    }
+    if (codePoint >= 0x450 && codePoint <= 0x45F) {
+        return codePoint - 0x50;
+    }
+    if ((codePoint >= 0x460 && codePoint <= 0x481)
+            || (codePoint >= 0x48A && codePoint <= 0x4BF)
+            || (codePoint >= 0x4D0 && codePoint <= 0x52F)) {
+        return codePoint & ~(uint32_t)1;
+    }
+    if (codePoint >= 0x4C1 && codePoint <= 0x4CE && codePoint % 2 == 0) {
+        return codePoint - 1;
+    }
+    if (codePoint == 0x4CF) {
+        return 0x4C0;
+    }
+    // Armenian
+    if (codePoint >= 0x561 && codePoint <= 0x586) {
+        return codePoint - 0x30;
+    }
+    return codePoint;
+}
+
+// An uppercase letter followed by a combining mark, and the single letter
+// they make, used to read decomposed (NFD) text
+typedef struct Composition {
+    uint32_t letter;
+    uint32_t mark;
+    uint32_t composed;
+} Composition;
+
+// the letters of Latin-1 and the common ones of Latin Extended-A
+const Composition compositions[] = {{'A', 0x300, 0xC0}, {'A', 0x301, 0xC1},
+        {'A', 0x302, 0xC2}, {'A', 0x303, 0xC3}, {'A', 0x308, 0xC4},
+        {'A', 0x30A, 0xC5}, {'C', 0x327, 0xC7}, {'E', 0x300, 0xC8},
+        {'E', 0x301, 0xC9}, {'E', 0x302, 0xCA}, {'E', 0x308, 0xCB},
+        {'I', 0x300, 0xCC}, {'I', 0x301, 0xCD}, {'I', 0x302, 0xCE},
+        {'I', 0x308, 0xCF}, {'N', 0x303, 0xD1}, {'O', 0x300, 0xD2},
+        {'O', 0x301, 0xD3}, {'O', 0x302, 0xD4}, {'O', 0x303, 0xD5},
+        {'O', 0x308, 0xD6}, {'U', 0x300, 0xD9}, {'U', 0x301, 0xDA},
+        {'U', 0x302, 0xDB}, {'U', 0x308, 0xDC}, {'Y', 0x301, 0xDD},
+        {'Y', 0x308, 0x178}, {'A', 0x306, 0x102}, {'A', 0x328, 0x104},
+        {'C', 0x301, 0x106}, {'C', 0x30C, 0x10C}, {'D', 0x30C, 0x10E},
+        {'E', 0x328, 0x118}, {'E', 0x30C, 0x11A}, {'G', 0x306, 0x11E},
+        {'I', 0x307, 0x130}, {'L', 0x301, 0x139}, {'L', 0x30C, 0x13D},
+        {'N', 0x301, 0x143}, {'N', 0x30C, 0x147}, {'O', 0x30B, 0x150},
+        {'R', 0x301, 0x154}, {'R', 0x30C, 0x158}, {'S', 0x301, 0x15A},
+        {'S', 0x327, 0x15E}, {'S', 0x30C, 0x160}, {'T', 0x327, 0x162},
+        {'T', 0x30C, 0x164}, {'U', 0x30A, 0x16E}, {'U', 0x30B, 0x170},
+        {'Z', 0x301, 0x179}, {'Z', 0x307, 0x17B}, {'Z', 0x30C, 0x17D}};
+const int numCompositions = sizeof(compositions) / sizeof(compositions[0]);
+
+/* Return the letter made by the uppercase letter followed by the combining
+ * mark, or 0 if there is no such letter.
+ */
+uint32_t compose_letter(uint32_t letter, uint32_t mark)
+{
+    for (int i = 0; i < numCompositions; i++) {
+        if (compositions[i].letter == letter && compositions[i].mark == mark) {
+            return compositions[i].composed;
+        }
+    }
+    return 0;
+}
+
+/* Decode the letter at the start of the UTF-8 text into its uppercase code
+ * point, composing it with any combining marks after it.
+ * Returns the number of bytes used, or 0 if the text doesn't start with a
+ * letter or has a combining mark that can't be composed.
+ */
+int decode_letter(const char* text, uint32_t* letter)
+{
+    const unsigned char* bytes = (const unsigned char*)text;
+    // ASCII letters not followed by a combining mark (starting with byte
+    // 0xCC or 0xCD) need no decoding or tables
+    if (bytes[0] < 0x80 && bytes[1] != 0xCC && bytes[1] != 0xCD) {
+        if ((unsigned)((bytes[0] | 0x20) - 'a') >= 26) {
+            return 0;
+        }
+        *letter = bytes[0] & ~0x20;
+        return 1;
+    }
+
+    int length;
+    if (bytes[0] < 0x80) {
+        *letter = bytes[0];
+        length = 1;
+    } else {
+        length = decode_utf8(text, letter);
+        if (length == 0) {
+            return 0;
+        }
+    }
+    if (!is_letter_code_point(*letter)) {
+        return 0;
+    }
+    *letter = to_upper_code_point(*letter);
+
+    // combining marks (0x300 to 0x36F) all start with byte 0xCC or 0xCD
+    uint32_t mark;
+    while (bytes[length] == 0xCC || bytes[length] == 0xCD) {
+        int markLength = decode_utf8(&text[length], &mark);
+        if (markLength == 0 || mark < 0x300 || mark > 0x36F) {
+            break;
+        }
+        *letter = compose_letter(*letter, mark);
+        if (*letter == 0) {
+            return 0;
+        }
+        length += markLength;
+    }
+    return length;
+}
+
+/* Checks if the provided UTF-8 string contains only letters.
+ * Returns 1 if it has anything else, including invalid UTF-8.
+ */
 int is_string_alpha(const char* letters)
 {
-    for (int i = 0; letters[i] != '\0'; i++) {
-        if (!isalpha(letters[i])) {
+    uint32_t letter;
+    for (int i = 0; letters[i] != '\0';) {
+        int length = decode_letter(&letters[i], &letter);
+        if (length == 0) {
             return 1;
         }
+        i += length;
     }
     return 0;
 }
 
+/* Return the number of letters in the UTF-8 string, which must contain only
+ * letters.
+ */
+int count_letters(const char* text)
+{
+    uint32_t letter;
+    int numLetters = 0;
+    for (int i = 0; text[i] != '\0'; numLetters++) {
+        i += decode_letter(&text[i], &letter);
+    }
+    return numLetters;
+}
+
 /* Given letters, verify they are all letters, and between min length provided
  * and the max length 13
  */
@@ -155,17 +546,16 @@ int validate_letters(char* letters, const int* minLength)
         fprintf(stderr, "unscramble: letter set is invalid\n");
         return invalidLetterSetStatus;
     }
-    // check it has max 13 letters
-    // type casting maxLettersLength and minLength from int to size_t,
-    // the same type as the return value of strlen
-    if (strlen(letters) > (size_t)maxLettersLength) {
+    // check it has max 13 letters, counting letters rather than bytes
+    int lettersLength = count_letters(letters);
+    if (lettersLength > maxLettersLength) {
         fprintf(stderr,
                 "unscramble: number of letters "
                 "should be no more than 13\n");
         return excessLettersLengthStatus;
     }
     // check it has more letters than the minLength provided
-    if (strlen(letters) < (size_t)*minLength) {
+    if (lettersLength < *minLength) {
         fprintf(stderr,
                 "unscramble: too few letters "
                 "for the given minimum length (%d)\n",
@@ -175,217 +565,881 @@ int validate_letters(char* letters, const int* minLength)
     return 0;
 }
 
-/* Randomly generate string of random letters with length determined 
-by the argument provided*/
-char* get_random_letters(int length) {
-    // allocate memory for the string
-    char* result = (char*)malloc((length + 1) * sizeof(char)); 
+// The letters of a dictionary, each mapped to a small integer symbol so that
+// words can be stored one byte per letter. Symbol 0 ends a word, symbols 1 to
+// dictionarySize are the letters of the dictionary in code point order,
+// followed by any letters only found in the rack. unknownSymbol stands for
+// every other letter.
+typedef struct Alphabet {
+    // the uppercase code point of each symbol
+    uint32_t* codePoints;
+    // the symbol of each ASCII code point, 0 if it isn't in the alphabet
+    uint8_t* asciiSymbols;
+    int dictionarySize;
+    int size;
+    int unknownSymbol;
+    // length of the letter count arrays, padded to countsAlignment
+    int countsWidth;
+} Alphabet;
 
-    if (result == NULL) {
-        printf("Memory allocation failed.\n");
-        return NULL;
+/* Free the memory used by the alphabet. */
+void free_alphabet(Alphabet* alphabet)
+{
+    free(alphabet->codePoints);
+    free(alphabet->asciiSymbols);
+}
+
+// The distinct letters found while discovering an alphabet: a bit set of
+// the ASCII letters and a sorted array of the others
+typedef struct LetterSet {
+    uint64_t ascii[2];
+    uint32_t* others;
+    int numOthers;
+    // set if there were more letters than maxAlphabetSize
+    int overflowed;
+} LetterSet;
+
+/* Add a letter past ASCII to the sorted letters of the set if missing. */
+void add_other_letter(LetterSet* set, uint32_t letter)
+{
+    int low = 0;
+    int high = set->numOthers;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (set->others[middle] < letter) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < set->numOthers && set->others[low] == letter) {
+        return;
     }
+    if (set->numOthers == maxAlphabetSize) {
+        set->overflowed = 1;
+        return;
+    }
+    memmove(&set->others[low + 1], &set->others[low],
+            (set->numOthers - low) * sizeof(uint32_t));
+    set->others[low] = letter;
+    set->numOthers++;
+}
 
-    srand(time(NULL)); // seed the random number generator
+/* Add the letters of the UTF-8 word to the set, decoding it once.
+ * Returns 1 if the word has anything but letters or is longer than
+ * maxLettersLength, so it can never be played, in which case nothing is
+ * added.
+ */
+int add_word_letters(LetterSet* set, const char* word)
+{
+    // plain ASCII words are checked a byte at a time without decoding,
+    // as long as no letter is followed by a combining mark
+    const unsigned char* bytes = (const unsigned char*)word;
+    uint64_t ascii[2] = {0, 0};
+    int i = 0;
+    for (; bytes[i] != '\0' && bytes[i] < 0x80 && bytes[i + 1] != 0xCC
+            && bytes[i + 1] != 0xCD;
+            i++) {
+        if ((unsigned)((bytes[i] | 0x20) - 'a') >= 26
+                || i == maxLettersLength) {
+            return 1;
+        }
+        unsigned letter = bytes[i] & ~0x20;
+        ascii[letter / 64] |= (uint64_t)1 << (letter % 64);
+    }
+    if (bytes[i] == '\0') {
+        set->ascii[0] |= ascii[0];
+        set->ascii[1] |= ascii[1];
+        return 0;
+    }
 
-    for (int i = 0; i < length; i++) {
-        // generate a random uppercase letter (ASCII values 65 to 90)
-        result[i] = 'A' + (rand() % 26);
+    // letters past ASCII are kept aside until the whole word is known to
+    // be letters, stopping as soon as it is too long to play
+    uint32_t others[maxLettersLength];
+    int numOthers = 0;
+    int numLetters = 0;
+    ascii[0] = 0;
+    ascii[1] = 0;
+    uint32_t letter;
+    for (i = 0; word[i] != '\0'; numLetters++) {
+        int length = decode_letter(&word[i], &letter);
+        if (length == 0 || numLetters == maxLettersLength) {
+            return 1;
+        }
+        if (letter < 128) {
+            ascii[letter / 64] |= (uint64_t)1 << (letter % 64);
+        } else {
+            others[numOthers++] = letter;
+        }
+        i += length;
     }
 
-    result[length] = '\0';
+    set->ascii[0] |= ascii[0];
+    set->ascii[1] |= ascii[1];
+    for (int i = 0; i < numOthers; i++) {
+        add_other_letter(set, others[i]);
+    }
+    return 0;
+}
 
-    return result;
+/* Return the symbol of the uppercase code point, or the unknown symbol if it
+ * isn't in the alphabet.
+ */
+int find_symbol(const Alphabet* alphabet, uint32_t codePoint)
+{
+    if (codePoint < 128) {
+        int symbol = alphabet->asciiSymbols[codePoint];
+        return symbol != 0 ? symbol : alphabet->unknownSymbol;
+    }
+
+    // the letters of the dictionary are sorted
+    int low = 1;
+    int high = alphabet->dictionarySize;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (alphabet->codePoints[middle] == codePoint) {
+            return middle;
+        }
+        if (alphabet->codePoints[middle] < codePoint) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    // the letters only found in the rack aren't
+    for (int symbol = alphabet->dictionarySize + 1; symbol <= alphabet->size;
+            symbol++) {
+        if (alphabet->codePoints[symbol] == codePoint) {
+            return symbol;
+        }
+    }
+    return alphabet->unknownSymbol;
+}
+
+/* Give the letter the next symbol of the alphabet. */
+void add_symbol(Alphabet* alphabet, uint32_t letter)
+{
+    alphabet->codePoints[++alphabet->size] = letter;
+    if (letter < 128) {
+        alphabet->asciiSymbols[letter] = alphabet->size;
+    }
+    alphabet->unknownSymbol = alphabet->size + 1;
 }
 
-/* Initialise the provided string with random letters
+/* Discover the alphabet of the dictionary from its words, skipping words that
+ * aren't only letters, then add the letters of the rack if provided.
+ * An empty dictionary gets the letters A-Z. Returns 1 if there are more than
+ * maxAlphabetSize letters, or 2 if memory allocation failed.
  */
-void initialise_letters(char* letters)
+int build_alphabet(Alphabet* alphabet, char** words, int numWords,
+        const char* letters)
 {
-    strcpy(letters, get_random_letters(defaultLettersLength));
+    LetterSet set = {{0, 0}, NULL, 0, 0};
+    set.others = malloc(maxAlphabetSize * sizeof(uint32_t));
+    if (set.others == NULL) {
+        return 2;
+    }
+    for (int i = 0; i < numWords; i++) {
+        add_word_letters(&set, words[i]);
+    }
+    if (set.ascii[0] == 0 && set.ascii[1] == 0 && set.numOthers == 0) {
+        for (unsigned letter = 'A'; letter <= 'Z'; letter++) {
+            set.ascii[letter / 64] |= (uint64_t)1 << (letter % 64);
+        }
+    }
+
+    int numDistinct = set.numOthers;
+    for (int letter = 0; letter < 128; letter++) {
+        numDistinct += (set.ascii[letter / 64] >> (letter % 64)) & 1;
+    }
+    if (set.overflowed || numDistinct > maxAlphabetSize) {
+        free(set.others);
+        return 1;
+    }
+
+    alphabet->codePoints = calloc(maxAlphabetSize + 2, sizeof(uint32_t));
+    alphabet->asciiSymbols = calloc(128, sizeof(uint8_t));
+    if (alphabet->codePoints == NULL || alphabet->asciiSymbols == NULL) {
+        free(set.others);
+        free_alphabet(alphabet);
+        return 2;
+    }
+
+    // symbol 0 ends a word, so symbols start from 1, ASCII letters coming
+    // before all others in code point order
+    alphabet->size = 0;
+    for (int letter = 0; letter < 128; letter++) {
+        if ((set.ascii[letter / 64] >> (letter % 64)) & 1) {
+            add_symbol(alphabet, letter);
+        }
+    }
+    for (int i = 0; i < set.numOthers; i++) {
+        add_symbol(alphabet, set.others[i]);
+    }
+    free(set.others);
+    alphabet->dictionarySize = alphabet->size;
+    alphabet->unknownSymbol = alphabet->size + 1;
+
+    // the rack's letters go after the dictionary's so the symbols of the
+    // dictionary don't depend on the rack
+    uint32_t letter;
+    for (int i = 0; letters != NULL && letters[i] != '\0';) {
+        int length = decode_letter(&letters[i], &letter);
+        if (length == 0) {
+            break;
+        }
+        i += length;
+        if (find_symbol(alphabet, letter) != alphabet->unknownSymbol) {
+            continue;
+        }
+        if (alphabet->size == maxAlphabetSize) {
+            free_alphabet(alphabet);
+            return 1;
+        }
+        add_symbol(alphabet, letter);
+    }
+
+    alphabet->countsWidth = (alphabet->unknownSymbol + countsAlignment)
+            / countsAlignment * countsAlignment;
+    return 0;
 }
 
-/* Check if the value for letters has been initialised, and
- * initialise with get_random_letters if not.
- * If initialised, check for its validity.
+/* Return a hash of the letters of the dictionary, used to check a rack
+ * table was built for the same alphabet.
  */
-int check_letters(char* letters, int* minLength)
+uint32_t hash_alphabet(const Alphabet* alphabet)
 {
-    // check if the letters is empty
-    if (strcmp(letters, " ") == 0) {
-        initialise_letters(letters);
-    } else {
-        // check for errors in letters
-        int lettersStatus = validate_letters(letters, minLength);
-        if (lettersStatus != 0) {
-            return lettersStatus;
+    // FNV-1a over the code points
+    uint32_t hash = 2166136261u;
+    for (int symbol = 1; symbol <= alphabet->dictionarySize; symbol++) {
+        hash = (hash ^ alphabet->codePoints[symbol]) * 16777619u;
+    }
+    return hash;
+}
+
+/* Return the FNV-1a hash of the word. */
+uint32_t hash_word(const char* word)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; word[i] != '\0'; i++) {
+        hash = (hash ^ (unsigned char)word[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/* Return a hash of the words of the dictionary, as symbols, used to check a
+ * rack table was built for the same words. The order of the words doesn't
+ * matter.
+ */
+uint32_t hash_words(char** words, int numWords)
+{
+    uint32_t hash = 0;
+    for (int i = 0; i < numWords; i++) {
+        // mix the bits of each word's hash before adding it so that the sum
+        // depends on all of them
+        uint32_t wordHash = hash_word(words[i]);
+        wordHash = (wordHash ^ (wordHash >> 16)) * 0x85EBCA6Bu;
+        wordHash = (wordHash ^ (wordHash >> 13)) * 0xC2B2AE35u;
+        hash += wordHash ^ (wordHash >> 16);
+    }
+    return hash;
+}
+
+/* Replace the UTF-8 text with the symbols of its letters, which never take
+ * more bytes than the text. Returns 1 if it has anything but letters.
+ */
+int encode_word_in_place(const Alphabet* alphabet, char* text)
+{
+    // plain ASCII letters are looked up a byte at a time without decoding,
+    // as long as they aren't followed by a combining mark
+    unsigned char* bytes = (unsigned char*)text;
+    int length = 0;
+    for (; bytes[length] != '\0' && bytes[length] < 0x80
+            && bytes[length + 1] != 0xCC && bytes[length + 1] != 0xCD;
+            length++) {
+        if ((unsigned)((bytes[length] | 0x20) - 'a') >= 26) {
+            return 1;
+        }
+        int symbol = alphabet->asciiSymbols[bytes[length] & ~0x20];
+        bytes[length] = symbol != 0 ? symbol : alphabet->unknownSymbol;
+    }
+    if (bytes[length] == '\0') {
+        return 0;
+    }
+
+    // otherwise decode and convert the rest in a single pass, giving up on
+    // the first character that isn't a letter
+    uint32_t letter;
+    for (int i = length; text[i] != '\0';) {
+        int letterLength = decode_letter(&text[i], &letter);
+        if (letterLength == 0) {
+            return 1;
         }
+        i += letterLength;
+        text[length++] = find_symbol(alphabet, letter);
     }
+    text[length] = '\0';
     return 0;
 }
 
-/* Given string, return the uppercase version. */
-char* convert_to_upper(char* word)
+/* Given UTF-8 text, return the word made of the symbols of its letters, or
+ * NULL if it has anything but letters.
+ */
+char* encode_word(const Alphabet* alphabet, const char* text)
+{
+    char* word = malloc(((int)strlen(text) + 1) * sizeof(char));
+    if (word == NULL) {
+        return NULL;
+    }
+    strcpy(word, text);
+    if (encode_word_in_place(alphabet, word) == 1) {
+        free(word);
+        return NULL;
+    }
+    return word;
+}
+
+/* Given a word made of symbols, return it as UTF-8 text. */
+char* decode_word(const Alphabet* alphabet, const char* word)
 {
-    // extra 1 for the null terminator at the end of the string
-    char* newWord = malloc(((int)strlen(word) + 1) * sizeof(char));
-    if (newWord == NULL) {
+    // a code point takes at most 4 bytes
+    char* text = malloc((4 * (int)strlen(word) + 1) * sizeof(char));
+    if (text == NULL) {
         return NULL;
     }
 
-    int i;
-    for (i = 0; word[i] != '\0'; i++) {
-        newWord[i] = toupper(word[i]);
+    int length = 0;
+    for (int i = 0; word[i] != '\0'; i++) {
+        length += encode_utf8(
+                alphabet->codePoints[(unsigned char)word[i]], &text[length]);
+    }
+    text[length] = '\0';
+    return text;
+}
+
+/* Count the symbols of the word into counts, which has countsWidth entries.
+ * Returns the length of the word.
+ */
+int count_word_letters(
+        const Alphabet* alphabet, const char* word, uint8_t* counts)
+{
+    memset(counts, 0, alphabet->countsWidth);
+    int length = 0;
+    for (; word[length] != '\0'; length++) {
+        counts[(unsigned char)word[length]]++;
+    }
+    return length;
+}
+
+/* Check if a word can be formed from the letters given the counts of both.
+ * Every entry is compared so the loop is easily vectorised.
+ */
+int letter_counts_can_form(
+        const Alphabet* alphabet, const uint8_t* inputCounts,
+        const uint8_t* lettersCounts)
+{
+    int missing = 0;
+    for (int symbol = 0; symbol < alphabet->countsWidth; symbol++) {
+        missing |= inputCounts[symbol] > lettersCounts[symbol];
     }
-    newWord[i] = '\0';
-    return newWord;
+    return missing;
 }
 
-// Used to keep track of the letter and its count.
-typedef struct CharCount {
-    char letter;
+// Stats for a single rack, as stored in the rack table.
+typedef struct RackStats {
+    // number of dictionary words that can be formed from the rack
+    uint16_t numAnswers;
+    // total score of guessing every answer
+    uint16_t maxScore;
+    // 1 if some answer uses every letter of the rack
+    uint8_t hasFullWord;
+    // length of the longest answer
+    uint8_t longestAnswer;
+} RackStats;
+
+// Header at the start of a rack table file, followed by numRacks RackStats
+// ordered by rack rank.
+typedef struct RackTableHeader {
+    char magic[4];
+    uint32_t rackLength;
+    uint32_t numRacks;
+    uint32_t minLength;
+    // the alphabet the table was built for
+    uint32_t alphabetSize;
+    uint32_t alphabetHash;
+    // the words the table was built from
+    uint32_t numWords;
+    uint32_t wordsHash;
+} RackTableHeader;
+
+// A rack table mapped into memory
+typedef struct RackTable {
+    const RackTableHeader* header;
+    const RackStats* stats;
+    size_t mapSize;
+} RackTable;
+
+// A dictionary signature and the number of words sharing it
+typedef struct SignatureEntry {
+    uint64_t signature;
     int count;
-} CharCount;
+} SignatureEntry;
+
+// Open addressing hash table of dictionary signatures.
+// Signature 0 marks an empty slot.
+typedef struct SignatureTable {
+    SignatureEntry* entries;
+    uint64_t mask;
+} SignatureTable;
+
+// The range of racks a single worker thread computes stats for
+typedef struct RackTableJob {
+    const SignatureTable* signatures;
+    RackStats* stats;
+    uint32_t firstRank;
+    uint32_t lastRank;
+    int minLength;
+} RackTableJob;
+
+/* Return n choose k. */
+uint64_t binomial(int n, int k)
+{
+    if (k < 0 || k > n) {
+        return 0;
+    }
+    uint64_t result = 1;
+    for (int i = 1; i <= k; i++) {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
 
-// Keep track of the array of CharCount and its size
-typedef struct CharCountArr {
-    CharCount* letters;
-    int size;
-} CharCountArr;
-
-/* Given letter check if it is inside the array of existing letters count,
- * if yes, add 1 to the count
- * else, add the new letter count to the array.
- * size provided externally to keep track of how big the array is.
- * numReads keeps track of how many unique letters have been added to
- * lettersCount,
- * bufferSize keeps track of the amount of memory assigned to lettersCount.
- */
-void check_in_letters_count(
-        char letter, CharCount** lettersCount, int* numReads, int* bufferSize)
-{
-    // allocate more space if necessary
-    if (*numReads >= *(bufferSize)-1) {
-        *bufferSize *= 2;
-        *lettersCount = realloc(*lettersCount, *bufferSize * sizeof(CharCount));
-    }
-
-    // check if letter already present in the array
-    // if yes, add 1 to the count
-    // else add the letter to the array
-    for (int i = 0; i < *numReads; i++) {
-        if ((*lettersCount)[i].letter == letter) {
-            (*lettersCount)[i].count++;
-            return;
+/* Return the number of distinct racks (multisets of the dictionary's
+ * letters) of the given length.
+ */
+uint64_t count_racks(const Alphabet* alphabet, int length)
+{
+    return binomial(alphabet->dictionarySize + length - 1, length);
+}
+
+/* Given the letter counts of a word, pack its symbols in ascending order
+ * into a signature. Symbols start at 1 so words of different lengths never
+ * share a signature.
+ */
+uint64_t pack_signature(const Alphabet* alphabet, const uint8_t* counts)
+{
+    uint64_t signature = 0;
+    for (int symbol = 1; symbol <= alphabet->dictionarySize; symbol++) {
+        for (int i = 0; i < counts[symbol]; i++) {
+            signature = (signature << signatureSymbolBits) | symbol;
         }
     }
+    return signature;
+}
 
-    // reach here if letter not found, then add the letter to the array
-    (*lettersCount)[*numReads].letter = letter;
-    (*lettersCount)[*numReads].count = 1;
-    *numReads += 1;
+/* Return the slot of the signature table the signature belongs in, which is
+ * either the slot holding it or the empty slot it should be inserted into.
+ */
+SignatureEntry* find_signature(const SignatureTable* table, uint64_t signature)
+{
+    uint64_t slot = (signature * 0x9E3779B97F4A7C15ULL) >> 32;
+    while (1) {
+        SignatureEntry* entry = &table->entries[slot & table->mask];
+        if (entry->signature == signature || entry->signature == 0) {
+            return entry;
+        }
+        slot++;
+    }
 }
 
-/* Given a string, return list containing each character and their count. */
-CharCountArr get_letter_count(char* word)
+/* Build a signature table of every word between minLength and maxLength
+ * long. Returns 1 if memory allocation failed.
+ */
+int build_signature_table(SignatureTable* table, const Alphabet* alphabet,
+        char** words, int numWords, int minLength, int maxLength)
 {
-    // keeps track of how many unique letters have been counted
-    int numLetterRead = 0;
-    // keep track of the amount of memory assigned to the counts
-    int bufferSize = 1;
+    // keep the table at most half full
+    uint64_t size = 1;
+    while (size < 2 * (uint64_t)numWords) {
+        size *= 2;
+    }
+    table->entries = calloc(size, sizeof(SignatureEntry));
+    if (table->entries == NULL) {
+        return 1;
+    }
+    table->mask = size - 1;
 
-    // dynamically allocate the size of lettersCount
-    CharCount* lettersCount = malloc(bufferSize * sizeof(CharCount));
+    uint8_t counts[alphabet->countsWidth];
+    for (int i = 0; i < numWords; i++) {
+        int length = (int)strlen(words[i]);
+        if (length < minLength || length > maxLength) {
+            continue;
+        }
+        count_word_letters(alphabet, words[i], counts);
+        uint64_t signature = pack_signature(alphabet, counts);
+        SignatureEntry* entry = find_signature(table, signature);
+        entry->signature = signature;
+        entry->count++;
+    }
+    return 0;
+}
 
-    // loop over the word
-    for (int i = 0; word[i] != '\0'; i++) {
-        check_in_letters_count(
-                word[i], &lettersCount, &numLetterRead, &bufferSize);
+/* Return the rank of the rack given its letters (symbol minus 1) sorted in
+ * ascending order. Adding i to the i-th letter turns the rack into a set,
+ * whose colexicographic rank is the rank of the rack.
+ */
+uint32_t rank_rack(const int* sortedLetters, int length)
+{
+    uint32_t rank = 0;
+    for (int i = 0; i < length; i++) {
+        rank += (uint32_t)binomial(sortedLetters[i] + i, i + 1);
     }
+    return rank;
+}
 
-    // return new struct that also keep track of the size of the array
-    CharCountArr newLetterCount = {lettersCount, numLetterRead};
+/* Given a rank, store the set it belongs to in ascending order into
+ * combination. Inverse of rank_rack, before subtracting i from each element.
+ */
+void unrank_combination(uint32_t rank, int* combination, int length)
+{
+    for (int i = length - 1; i >= 0; i--) {
+        int element = i;
+        while (binomial(element + 1, i + 1) <= rank) {
+            element++;
+        }
+        combination[i] = element;
+        rank -= (uint32_t)binomial(element, i + 1);
+    }
+}
 
-    return newLetterCount;
+/* Advance the set to the one with the next colexicographic rank. */
+void next_combination(int* combination, int length)
+{
+    for (int i = 0; i < length; i++) {
+        if (i == length - 1 || combination[i] + 1 < combination[i + 1]) {
+            combination[i]++;
+            for (int j = 0; j < i; j++) {
+                combination[j] = j;
+            }
+            return;
+        }
+    }
+}
+
+/* Add value to the counter without letting it wrap around. */
+void add_saturated(uint16_t* counter, int value)
+{
+    int total = *counter + value;
+    *counter = total > UINT16_MAX ? UINT16_MAX : total;
 }
 
-/* Compare two arrays of CharCount to see if the the letter array has all
- * the characters of the input and >= counts of all the characters as well.
+/* Look up every sub-rack of the rack in the signature table and add the
+ * words found to the stats. The rack is given as its distinct letters and
+ * their counts, group is the letter currently being chosen.
  */
-int compare_letters_counts(CharCountArr inputCounts, CharCountArr lettersCounts)
+void add_sub_racks(const RackTableJob* job, const int* letters,
+        const int* counts, int numGroups, int group, uint64_t signature,
+        int length, RackStats* stats)
 {
-    // loop through all the CharCount pairs of inputCounts
-    // for each pair, loop through all the CharCount pairs of lettersCounts
-    // to see if there is a match and if so, does the count match
-    for (int i = 0; i < inputCounts.size; i++) {
-        // 1 for current input letter not found
-        // 0 for found
-        int letterFound = 1;
+    if (group == numGroups) {
+        if (length < job->minLength) {
+            return;
+        }
+        SignatureEntry* entry = find_signature(job->signatures, signature);
+        if (entry->signature == 0) {
+            return;
+        }
+        int score = length + (length == tableRackLength ? bonusScore : 0);
+        add_saturated(&stats->numAnswers, entry->count);
+        add_saturated(&stats->maxScore, entry->count * score);
+        if (length > stats->longestAnswer) {
+            stats->longestAnswer = length;
+        }
+        if (length == tableRackLength) {
+            stats->hasFullWord = 1;
+        }
+        return;
+    }
 
-        // check if the current input letter is inside the letters
-        // if letter present but count doesn't match immediately return 1
-        // if letter present and count matches set letterFound to 0 and
-        // proceed to the next inputer letter.
-        // If input letter not found, letterFound flag will trigger and return
-        // 1 as well.
-        for (int j = 0; j < lettersCounts.size; j++) {
-            CharCount input = inputCounts.letters[i];
-            CharCount letters = lettersCounts.letters[j];
+    // use the current letter 0 to counts[group] times
+    for (int i = 0; i <= counts[group]; i++) {
+        add_sub_racks(job, letters, counts, numGroups, group + 1, signature,
+                length, stats);
+        signature = (signature << signatureSymbolBits) | (letters[group] + 1);
+        length++;
+    }
+}
 
-            if (input.letter == letters.letter) {
-                if (input.count > letters.count) {
-                    return 1;
-                }
-                letterFound = 0;
-                break;
+/* Compute the stats of every rack in the job's range of ranks. */
+void* run_rack_table_job(void* arg)
+{
+    const RackTableJob* job = arg;
+    int combination[tableRackLength];
+    unrank_combination(job->firstRank, combination, tableRackLength);
+
+    for (uint32_t rank = job->firstRank; rank < job->lastRank; rank++) {
+        // group the sorted letters (symbol minus 1) of the rack into
+        // distinct letters and their counts
+        int letters[tableRackLength];
+        int counts[tableRackLength];
+        int numGroups = 0;
+        for (int i = 0; i < tableRackLength; i++) {
+            int letter = combination[i] - i;
+            if (numGroups > 0 && letters[numGroups - 1] == letter) {
+                counts[numGroups - 1]++;
+            } else {
+                letters[numGroups] = letter;
+                counts[numGroups++] = 1;
             }
         }
 
-        if (letterFound == 1) {
-            return 1;
+        RackStats* stats = &job->stats[rank];
+        memset(stats, 0, sizeof(RackStats));
+        add_sub_racks(job, letters, counts, numGroups, 0, 0, 0, stats);
+        next_combination(combination, tableRackLength);
+    }
+    return NULL;
+}
+
+/* Compute the stats of every rack of tableRackLength letters from the words
+ * of the dictionary, splitting the racks across all cores, and save them to
+ * the file at path. Returns 1 on failure, including alphabets with too many
+ * racks to rank.
+ */
+int build_rack_table(const char* path, const Alphabet* alphabet, char** words,
+        int numWords, int minLength)
+{
+    if (count_racks(alphabet, tableRackLength) > UINT32_MAX) {
+        return 1;
+    }
+    uint32_t numRacks = count_racks(alphabet, tableRackLength);
+
+    SignatureTable signatures;
+    if (build_signature_table(&signatures, alphabet, words, numWords,
+                minLength, tableRackLength)) {
+        return 1;
+    }
+
+    RackStats* stats = malloc(numRacks * sizeof(RackStats));
+    long numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads < 1) {
+        numThreads = defaultNumThreads;
+    }
+    pthread_t* threads = malloc(numThreads * sizeof(pthread_t));
+    RackTableJob* jobs = malloc(numThreads * sizeof(RackTableJob));
+    if (stats == NULL || threads == NULL || jobs == NULL) {
+        free(signatures.entries);
+        free(stats);
+        free(threads);
+        free(jobs);
+        return 1;
+    }
+
+    // give each thread an equal share of the racks
+    // if a thread can't be started, its share is computed on this thread
+    int* started = calloc(numThreads, sizeof(int));
+    if (started == NULL) {
+        free(signatures.entries);
+        free(stats);
+        free(threads);
+        free(jobs);
+        return 1;
+    }
+    for (long i = 0; i < numThreads; i++) {
+        jobs[i].signatures = &signatures;
+        jobs[i].stats = stats;
+        jobs[i].firstRank = (uint64_t)numRacks * i / numThreads;
+        jobs[i].lastRank = (uint64_t)numRacks * (i + 1) / numThreads;
+        jobs[i].minLength = minLength;
+        started[i] = pthread_create(
+                             &threads[i], NULL, run_rack_table_job, &jobs[i])
+                == 0;
+    }
+    for (long i = 0; i < numThreads; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            run_rack_table_job(&jobs[i]);
         }
     }
+    free(started);
+    free(signatures.entries);
+    free(threads);
+    free(jobs);
+
+    RackTableHeader header;
+    memcpy(header.magic, rackTableMagic, sizeof(header.magic));
+    header.rackLength = tableRackLength;
+    header.numRacks = numRacks;
+    header.minLength = minLength;
+    header.alphabetSize = alphabet->dictionarySize;
+    header.alphabetHash = hash_alphabet(alphabet);
+    header.numWords = numWords;
+    header.wordsHash = hash_words(words, numWords);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        free(stats);
+        return 1;
+    }
+    int failed = fwrite(&header, sizeof(header), 1, file) != 1
+            || fwrite(stats, sizeof(RackStats), numRacks, file) != numRacks;
+    free(stats);
+    if (fclose(file) != 0 || failed) {
+        return 1;
+    }
     return 0;
 }
 
-/* Check if the word provided can be formed using the provided letters set.
- * Done by counting the number of letters.
+/* Map the rack table at path into memory. The table must have been built
+ * with the same minimum length, alphabet and words. Returns 1 if the table
+ * can't be used.
  */
-int letter_can_form(char* input, char* letters)
+int load_rack_table(const char* path, int minLength, const Alphabet* alphabet,
+        char** words, int numWords, RackTable* table)
 {
-    // convert input and letters both to uppercase for easy comparison
-    char* newInput = convert_to_upper(input);
-    char* newLetters = convert_to_upper(letters);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0
+            || (size_t)fileStat.st_size < sizeof(RackTableHeader)) {
+        close(fd);
+        return 1;
+    }
+    void* map = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 1;
+    }
+
+    // check the table matches what this build of unscramble would write
+    const RackTableHeader* header = map;
+    uint64_t numRacks = count_racks(alphabet, tableRackLength);
+    if (memcmp(header->magic, rackTableMagic, sizeof(header->magic)) != 0
+            || header->rackLength != (uint32_t)tableRackLength
+            || header->numRacks != numRacks
+            || header->minLength != (uint32_t)minLength
+            || header->alphabetSize != (uint32_t)alphabet->dictionarySize
+            || header->alphabetHash != hash_alphabet(alphabet)
+            || header->numWords != (uint32_t)numWords
+            || header->wordsHash != hash_words(words, numWords)
+            || (size_t)fileStat.st_size != sizeof(RackTableHeader)
+                            + numRacks * sizeof(RackStats)) {
+        munmap(map, fileStat.st_size);
+        return 1;
+    }
+
+    table->header = header;
+    table->stats = (const RackStats*)(header + 1);
+    table->mapSize = fileStat.st_size;
+    return 0;
+}
+
+/* Unmap a rack table loaded by load_rack_table. */
+void free_rack_table(RackTable* table)
+{
+    munmap((void*)table->header, table->mapSize);
+}
+
+/* Return the stats of the given letters (as symbols), or NULL if the
+ * letters aren't a rack stored in the table.
+ */
+const RackStats* lookup_rack_stats(
+        const RackTable* table, const Alphabet* alphabet, const char* letters)
+{
+    if (strlen(letters) != (size_t)tableRackLength) {
+        return NULL;
+    }
+    uint8_t counts[alphabet->countsWidth];
+    count_word_letters(alphabet, letters, counts);
+
+    // sort the letters by expanding their counts, letters only found in
+    // the rack aren't in the table
+    int sortedLetters[tableRackLength];
+    int numSorted = 0;
+    for (int symbol = 1; symbol < alphabet->countsWidth; symbol++) {
+        if (counts[symbol] > 0 && symbol > alphabet->dictionarySize) {
+            return NULL;
+        }
+        for (int i = 0; i < counts[symbol]; i++) {
+            sortedLetters[numSorted++] = symbol - 1;
+        }
+    }
+    return &table->stats[rank_rack(sortedLetters, tableRackLength)];
+}
+
+/* Randomly generate string of random letters of the dictionary's alphabet,
+as symbols, with length determined by the argument provided*/
+char* get_random_letters(const Alphabet* alphabet, int length) {
+    // allocate memory for the string
+    char* result = (char*)malloc((length + 1) * sizeof(char)); 
 
-    // if initialisation failed, immediately free the memories
-    if (newInput == NULL) {
-        free(newInput);
+    if (result == NULL) {
+        printf("Memory allocation failed.\n");
+        return NULL;
     }
-    if (newLetters == NULL) {
-        free(newLetters);
+
+    for (int i = 0; i < length; i++) {
+        // generate a random symbol of the dictionary (1 to dictionarySize)
+        result[i] = 1 + (rand() % alphabet->dictionarySize);
     }
 
-    // get counts for inputs and letters
-    CharCountArr inputsCount = get_letter_count(newInput);
-    CharCountArr lettersCount = get_letter_count(newLetters);
+    result[length] = '\0';
 
-    // compare the counts
-    if (compare_letters_counts(inputsCount, lettersCount)) {
-        // free the memories before returning error
-        free(newInput);
-        free(newLetters);
-        free(inputsCount.letters);
-        free(lettersCount.letters);
-        return 1;
+    return result;
+}
+
+/* Return random letters (as symbols) to play with.
+ * If a rack table is provided, keep generating racks until one has a word
+ * using every letter.
+ */
+char* initialise_letters(const Alphabet* alphabet, const RackTable* table)
+{
+    srand(time(NULL)); // seed the random number generator
+
+    char* letters = get_random_letters(alphabet, defaultLettersLength);
+    for (int i = 0; table != NULL && letters != NULL && i < maxRackRerolls;
+            i++) {
+        const RackStats* stats = lookup_rack_stats(table, alphabet, letters);
+        if (stats == NULL || stats->hasFullWord) {
+            break;
+        }
+        free(letters);
+        letters = get_random_letters(alphabet, defaultLettersLength);
+    }
+    return letters;
+}
+
+/* Check the validity of the letters if provided. If not, they are
+ * initialised with get_random_letters once the dictionary is read.
+ */
+int check_letters(char* letters, int* minLength)
+{
+    if (letters != NULL) {
+        // check for errors in letters
+        int lettersStatus = validate_letters(letters, minLength);
+        if (lettersStatus != 0) {
+            return lettersStatus;
+        }
     }
-    // free used memories before returning success
-    free(newInput);
-    free(newLetters);
-    free(inputsCount.letters);
-    free(lettersCount.letters);
     return 0;
 }
 
+/* Check if the word provided can be formed using the provided letters set.
+ * Both are symbols of the alphabet, already folded to uppercase.
+ * Done by counting the number of letters.
+ */
+int letter_can_form(const Alphabet* alphabet, char* input, char* letters)
+{
+    uint8_t inputCounts[alphabet->countsWidth];
+    uint8_t lettersCounts[alphabet->countsWidth];
+    count_word_letters(alphabet, input, inputCounts);
+    count_word_letters(alphabet, letters, lettersCounts);
+    return letter_counts_can_form(alphabet, inputCounts, lettersCounts);
+}
+
 /* Given an array of strings, print out every single one in separate lines. */
 void print_string_array(char** stringArr)
 {
@@ -394,8 +1448,7 @@ void print_string_array(char** stringArr)
     }
 }
 
-/* Read a single line from the file.
- * Convert every single character to uppercase as well.
+/* Read a single line from the file as UTF-8 text.
  * REF: Ed Lessons Week 3.2 file handling
  * */
 char* read_line(FILE* file)
@@ -411,7 +1464,8 @@ char* read_line(FILE* file)
     }
 
     while (1) {
-        next = fgetc(file);
+        // only one thread reads at a time, so the stream needn't be locked
+        next = getc_unlocked(file);
         if (next == EOF && numReads == 0) {
             free(line);
             return NULL;
@@ -424,7 +1478,7 @@ char* read_line(FILE* file)
             line[numReads] = '\0';
             break;
         }
-        line[numReads++] = toupper(next);
+        line[numReads++] = next;
     }
     return line;
 }
@@ -459,12 +1513,8 @@ void read_file(FILE* file, char*** words, int* numLines, int* size)
             }
         }
 
-        // allocate memory for the current line
-        (*words)[*numLines] = malloc(((int)strlen(line) + 1) * sizeof(char));
-
-        // copy the line into the array
-        strcpy((*words)[*numLines], line);
-        free(line);
+        // keep the line read as the word, without copying it
+        (*words)[*numLines] = line;
         *numLines += 1;
     }
 }
@@ -489,20 +1539,303 @@ int check_file(const char* filename, char*** words, int* numLines, int* size)
     return 0;
 }
 
-/* Add the length of the input to the score.
- * If it is the same as the max length, add extra 10 to the score.
+/* Add the word to the open addressing hash set of words (NULL marking an
+ * empty slot) unless it is already there. Returns 1 if it already was.
  */
-void add_score(int* score, int inputLen, int maxLen)
+int add_unique_word(const char** wordSet, uint32_t mask, const char* word)
+{
+    for (uint32_t slot = hash_word(word);; slot++) {
+        const char** entry = &wordSet[slot & mask];
+        if (*entry == NULL) {
+            *entry = word;
+            return 0;
+        }
+        if (strcmp(*entry, word) == 0) {
+            return 1;
+        }
+    }
+}
+
+// Dictionary words of a single length
+typedef struct WordBucket {
+    const char** words;
+    int size;
+    int capacity;
+} WordBucket;
+
+// Dictionary words grouped into buckets by length, up to maxLettersLength
+typedef struct WordIndex {
+    WordBucket* buckets;
+    int maxLength;
+} WordIndex;
+
+/* Free the buckets of the word index, but not the words themselves. */
+void free_word_index(WordIndex* index)
+{
+    if (index->buckets == NULL) {
+        return;
+    }
+    for (int length = 0; length <= index->maxLength; length++) {
+        free(index->buckets[length].words);
+    }
+    free(index->buckets);
+    index->buckets = NULL;
+}
+
+/* Add the word of the given length to the bucket for its length, growing
+ * the bucket if it is full. Returns 1 if memory allocation failed.
+ */
+int add_indexed_word(WordIndex* index, const char* word, int length)
 {
-    *score += inputLen;
+    WordBucket* bucket = &index->buckets[length];
+    if (bucket->size == bucket->capacity) {
+        int capacity = bucket->capacity == 0 ? initialWordsSize
+                                             : 2 * bucket->capacity;
+        const char** words
+                = realloc(bucket->words, capacity * sizeof(char*));
+        if (words == NULL) {
+            return 1;
+        }
+        bucket->words = words;
+        bucket->capacity = capacity;
+    }
+    bucket->words[bucket->size++] = word;
+    return 0;
+}
+
+/* Read the dictionary, discover its alphabet (along with the letters of the
+ * rack if provided) and convert every word to symbols, dropping words that
+ * aren't only letters, are too long to play, and words that are the same as an earlier one once
+ * case is ignored. If index isn't NULL the words are also grouped into it
+ * by length as they are converted, leaving its buckets NULL if there isn't
+ * enough memory. Returns 1 if the dictionary can't be used.
+ */
+int load_dictionary(const char* filename, const char* letters, char*** words,
+        int* numWords, Alphabet* alphabet, WordIndex* index)
+{
+    int size = initialWordsSize;
+    *words = calloc(sizeof(char*), size);
+    int numLines;
+    if (check_file(filename, words, &numLines, &size) == 1) {
+        free(*words);
+        return 1;
+    }
+
+    // keep the set of words at most half full
+    uint32_t setSize = 1;
+    while (setSize < 2 * (uint32_t)numLines) {
+        setSize *= 2;
+    }
+    const char** wordSet = calloc(setSize, sizeof(char*));
+
+    int alphabetStatus = wordSet == NULL
+            ? 2
+            : build_alphabet(alphabet, *words, numLines, letters);
+    if (alphabetStatus != 0) {
+        free(wordSet);
+        if (alphabetStatus == 1) {
+            fprintf(stderr,
+                    "unscramble: dictionary named \"%s\" has more than %d "
+                    "letters\n",
+                    filename, maxAlphabetSize);
+        } else {
+            fprintf(stderr,
+                    "unscramble: not enough memory to read dictionary named "
+                    "\"%s\"\n",
+                    filename);
+        }
+        for (int i = 0; i < numLines; i++) {
+            free((*words)[i]);
+        }
+        free(*words);
+        return 1;
+    }
+
+    if (index != NULL) {
+        index->maxLength = maxLettersLength;
+        index->buckets = calloc(index->maxLength + 1, sizeof(WordBucket));
+    }
+
+    *numWords = 0;
+    for (int i = 0; i < numLines; i++) {
+        // words longer than maxLettersLength can never be played
+        int length;
+        if (encode_word_in_place(alphabet, (*words)[i]) == 1
+                || (length = (int)strlen((*words)[i])) > maxLettersLength
+                || add_unique_word(wordSet, setSize - 1, (*words)[i]) == 1) {
+            free((*words)[i]);
+            continue;
+        }
+        (*words)[(*numWords)++] = (*words)[i];
+        if (index != NULL && index->buckets != NULL
+                && add_indexed_word(index, (*words)[i], length) == 1) {
+            free_word_index(index);
+        }
+    }
+    free(wordSet);
+    // read_file always leaves room for the NULL ending the words
+    (*words)[*numWords] = NULL;
+    return 0;
+}
 
+/* Return the score for guessing a word of length inputLen, which is its
+ * length plus an extra 10 if it is the same as the max length.
+ */
+int word_score(int inputLen, int maxLen)
+{
     if (inputLen == maxLen) {
-        *score += bonusScore;
+        return inputLen + bonusScore;
     }
+    return inputLen;
+}
+
+/* Add the score of the input to the score. */
+void add_score(int* score, int inputLen, int maxLen)
+{
+    *score += word_score(inputLen, maxLen);
 
     printf("OK! Score so far is %d\n", *score);
 }
 
+// A word and the score for guessing it
+typedef struct ScoredWord {
+    const char* word;
+    int score;
+} ScoredWord;
+
+// Min-heap of the best words found so far, the worst of them at the root
+typedef struct TopWords {
+    ScoredWord* words;
+    int size;
+    int capacity;
+} TopWords;
+
+/* Check if word a ranks above word b: higher score first, then
+ * alphabetical order.
+ */
+int is_better_word(ScoredWord a, ScoredWord b)
+{
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    return strcmp(a.word, b.word) < 0;
+}
+
+/* Restore the heap property by moving the word at position i down. */
+void sift_down_top_words(TopWords* top, int i)
+{
+    while (1) {
+        int worst = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < top->size
+                && is_better_word(top->words[worst], top->words[left])) {
+            worst = left;
+        }
+        if (right < top->size
+                && is_better_word(top->words[worst], top->words[right])) {
+            worst = right;
+        }
+        if (worst == i) {
+            return;
+        }
+        ScoredWord temp = top->words[i];
+        top->words[i] = top->words[worst];
+        top->words[worst] = temp;
+        i = worst;
+    }
+}
+
+/* Add the word to the best words if it ranks among them. */
+void offer_top_word(TopWords* top, ScoredWord word)
+{
+    if (top->size < top->capacity) {
+        // move the word up until its parent is worse than it
+        int i = top->size++;
+        while (i > 0 && is_better_word(top->words[(i - 1) / 2], word)) {
+            top->words[i] = top->words[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        top->words[i] = word;
+    } else if (is_better_word(word, top->words[0])) {
+        top->words[0] = word;
+        sift_down_top_words(top, 0);
+    }
+}
+
+/* qsort comparator putting better words first */
+int compare_scored_words(const void* a, const void* b)
+{
+    return is_better_word(*(const ScoredWord*)b, *(const ScoredWord*)a)
+            - is_better_word(*(const ScoredWord*)a, *(const ScoredWord*)b);
+}
+
+/* Find the k best words at least minLength long that can be formed from the
+ * letters, saving them best first into result. Buckets are visited from the
+ * longest words down, stopping once a shorter word can no longer score
+ * higher than the worst word kept. Returns the number of words found.
+ */
+int find_top_words(const WordIndex* index, const Alphabet* alphabet,
+        const char* letters, int minLength, int k, ScoredWord* result)
+{
+    if (k <= 0) {
+        return 0;
+    }
+    uint8_t lettersCounts[alphabet->countsWidth];
+    int lettersLength = count_word_letters(alphabet, letters, lettersCounts);
+    TopWords top = {result, 0, k};
+
+    int longest = lettersLength < index->maxLength ? lettersLength
+                                                   : index->maxLength;
+    uint8_t remaining[alphabet->countsWidth];
+    for (int length = longest; length >= minLength; length--) {
+        int score = word_score(length, lettersLength);
+        if (top.size == top.capacity && top.words[0].score > score) {
+            break;
+        }
+
+        const WordBucket* bucket = &index->buckets[length];
+        for (int i = 0; i < bucket->size; i++) {
+            // use up the letters one symbol at a time, giving up on the
+            // word at the first symbol that has run out
+            const unsigned char* symbols
+                    = (const unsigned char*)bucket->words[i];
+            memcpy(remaining, lettersCounts, alphabet->countsWidth);
+            int j = 0;
+            while (j < length && remaining[symbols[j]] > 0) {
+                remaining[symbols[j++]]--;
+            }
+            if (j == length) {
+                ScoredWord word = {bucket->words[i], score};
+                offer_top_word(&top, word);
+            }
+        }
+    }
+
+    qsort(result, top.size, sizeof(ScoredWord), compare_scored_words);
+    return top.size;
+}
+
+/* Print the k best words that could have been guessed with the letters. */
+void print_top_words(const WordIndex* index, const Alphabet* alphabet,
+        const char* letters, const int* minLength, int k)
+{
+    ScoredWord* topWords = malloc(k * sizeof(ScoredWord));
+    if (topWords == NULL) {
+        return;
+    }
+
+    int numTopWords = find_top_words(
+            index, alphabet, letters, *minLength, k, topWords);
+    printf("Best possible words:\n");
+    for (int i = 0; i < numTopWords; i++) {
+        char* text = decode_word(alphabet, topWords[i].word);
+        printf("%s (%d)\n", text, topWords[i].score);
+        free(text);
+    }
+    free(topWords);
+}
+
 /* Determines what to print based on the final score */
 int exit_game(const int* score)
 {
@@ -527,6 +1860,14 @@ void print_welcome(const int* minLength, int lettersLength, char* letters)
             *minLength, lettersLength, letters);
 }
 
+/* Print how many words the letters make, as found in the rack table */
+void print_rack_stats(const RackStats* stats)
+{
+    printf("There are %d words to find worth %d points%s\n",
+            stats->numAnswers, stats->maxScore,
+            stats->hasFullWord ? ", including one using every letter" : "");
+}
+
 /* Checks if the input has already been guessed */
 int input_already_guessed(char* input, char** guesses)
 {
@@ -572,19 +1913,14 @@ int input_in_dictionary(char* input, char** words, char** guesses,
     return 1;
 }
 
-/* Check if the user input is valid.
- * Perform checks on only letters in the input, length of input, can be formed
- * with available letters, guessed before, is a valid word.
+/* Check if the user input (as symbols) is valid.
+ * Perform checks on length of input, can be formed with available letters,
+ * guessed before, is a valid word.
  */
-int check_input(char* input, const int* minLength, char* letters, char** words,
-        char** guesses, int* numValidGuess, int* guessesSize)
+int check_input(const Alphabet* alphabet, char* input, const int* minLength,
+        char* letters, char** words, char** guesses, int* numValidGuess,
+        int* guessesSize)
 {
-    if (is_string_alpha(input)) {
-        printf("Word must contain only letters\n");
-        free(input);
-        return 1;
-    }
-
     if ((int)strlen(input) < *minLength) {
         printf("Word too short - it must be at least %d characters long\n",
                 *minLength);
@@ -599,7 +1935,7 @@ int check_input(char* input, const int* minLength, char* letters, char** words,
         return 1;
     }
 
-    if (letter_can_form(input, letters)) {
+    if (letter_can_form(alphabet, input, letters)) {
         printf("Word can't be formed with available letters\n");
         free(input);
         return 1;
@@ -621,24 +1957,48 @@ int check_input(char* input, const int* minLength, char* letters, char** words,
 }
 
 /* Start the game with the welcome message and start asking for user input.
+ * The letters and words are symbols of the alphabet, lettersText is the
+ * letters as shown to the user.
  * REF: Ed lesson Week 3.2 file handling.
  */
-int start_game(int* minLength, char* letters, char** words)
+int start_game(int* minLength, char* letters, char* lettersText, char** words,
+        const Alphabet* alphabet, const RackStats* rackStats, WordIndex* index,
+        int topK)
 {
     int score = 0;
     int numValidGuess = 0;
     int guessesSize = initialWordsSize;
     char** guesses = calloc(sizeof(char*), guessesSize);
+    char* line;
     char* input;
 
     // Print welcome message
-    print_welcome(minLength, (int)strlen(letters), letters);
+    print_welcome(minLength, (int)strlen(letters), lettersText);
+    if (rackStats != NULL) {
+        print_rack_stats(rackStats);
+    }
+
+    // the words were indexed while loading the dictionary if the best words
+    // will be revealed
+    if (topK > 0 && index->buckets == NULL) {
+        fprintf(stderr, "unscramble: not enough memory to find the best "
+                        "words\n");
+    }
 
     // Start the game
-    while ((input = read_line(stdin))) {
+    while ((line = read_line(stdin))) {
+        // convert the input to symbols, which fails if it has anything but
+        // letters
+        input = encode_word(alphabet, line);
+        free(line);
+        if (input == NULL) {
+            printf("Word must contain only letters\n");
+            continue;
+        }
+
         // implement the checks on user input
         // if any error occur, immediately ask for the next input
-        if (check_input(input, minLength, letters, words, guesses,
+        if (check_input(alphabet, input, minLength, letters, words, guesses,
                     &numValidGuess, &guessesSize)) {
             continue;
         }
@@ -647,6 +2007,14 @@ int start_game(int* minLength, char* letters, char** words)
         add_score(&score, (int)strlen(input), (int)strlen(letters));
         free(input);
     }
+    int exitStatus = exit_game(&score);
+
+    // reveal the best words that could have been guessed if asked to
+    if (index->buckets != NULL) {
+        print_top_words(index, alphabet, letters, minLength, topK);
+        free_word_index(index);
+    }
+
     // free the guesses and words
     for (int i = 0; i < numValidGuess; i++) {
         free(guesses[i]);
@@ -656,7 +2024,36 @@ int start_game(int* minLength, char* letters, char** words)
         free(words[i]);
     }
     free(words);
-    return exit_game(&score);
+    return exitStatus;
+}
+
+/* Read all words from the dictionary at dict and save the stats of every rack
+ * to the rack table at path. Return the exit status of the program.
+ */
+int build_table_from_file(const char* path, const char* dict, int minLength)
+{
+    Alphabet alphabet;
+    char** words;
+    int numWords;
+    if (load_dictionary(dict, NULL, &words, &numWords, &alphabet, NULL)
+            == 1) {
+        return invalidDictStatus;
+    }
+
+    int buildStatus
+            = build_rack_table(path, &alphabet, words, numWords, minLength);
+    for (int i = 0; i < numWords; i++) {
+        free(words[i]);
+    }
+    free(words);
+    free_alphabet(&alphabet);
+
+    if (buildStatus == 1) {
+        fprintf(stderr, "unscramble: rack table named \"%s\" cannot be built\n",
+                path);
+        return rackTableErrorStatus;
+    }
+    return 0;
 }
 
 /* Starts the entire program. Validates and saves arguments provided.
@@ -664,7 +2061,7 @@ int start_game(int* minLength, char* letters, char** words)
  */
 int main(int argc, char** argv)
 {
-    // Check even number of arguments and total is less than or equal to 6
+    // Check even number of arguments and total is less than or equal to 12
     // minus 1 to account for the program name included in argc
     int realArgc = argc - 1;
     if (!(realArgc % 2 == 0 && realArgc <= maxArgumentsLength)) {
@@ -673,13 +2070,20 @@ int main(int argc, char** argv)
 
     // verify argument names are valid and assigning the values
     int minLength = 0;
-    char letters[maxLettersLength];
-    strcpy(letters, " ");
+    // letters provided, NULL if they should be randomly generated
+    char* letters = NULL;
     // dynamically allocate memory for dict
     char* dict = malloc(initialDictSize * sizeof(char));
+    // paths to the rack table to use and to build, NULL if not provided
+    char* table = NULL;
+    char* buildTable = NULL;
+    // number of best words to reveal after the game, 0 if not provided
+    int topK = 0;
 
     // storing arugments provided in approproiate variables
-    if (check_arguments(realArgc, argv, &minLength, letters, dict) == 1) {
+    if (check_arguments(realArgc, argv, &minLength, &letters, dict, &table,
+                &buildTable, &topK)
+            == 1) {
         free(dict);
         return print_usage_err();
     }
@@ -693,6 +2097,13 @@ int main(int argc, char** argv)
         return invalidLengthStatus;
     }
 
+    // build the rack table instead of playing if asked to
+    if (buildTable != NULL) {
+        int buildStatus = build_table_from_file(buildTable, dict, minLength);
+        free(dict);
+        return buildStatus;
+    }
+
     // check letters are valid
     int letterStatus = check_letters(letters, &minLength);
     if (letterStatus != 0) {
@@ -700,14 +2111,67 @@ int main(int argc, char** argv)
         return letterStatus;
     }
 
-    // check directory provided works and saves all the content of the file
-    int size = initialWordsSize;
-    char** words = calloc(sizeof(char*), size);
-    int numLines;
-    if (check_file(dict, &words, &numLines, &size) == 1) {
+    // check directory provided works, saves all the content of the file
+    // and finds the alphabet of the dictionary and the letters, grouping the
+    // words by length if the best words will be revealed
+    Alphabet alphabet;
+    char** words;
+    int numWords;
+    WordIndex index = {NULL, 0};
+    if (load_dictionary(dict, letters, &words, &numWords, &alphabet,
+                topK > 0 ? &index : NULL)
+            == 1) {
         free(dict);
         return invalidDictStatus;
     }
     free(dict);
-    return start_game(&minLength, letters, words);
+
+    // load the rack table used to pick random letters
+    RackTable rackTable;
+    if (table != NULL
+            && load_rack_table(
+                       table, minLength, &alphabet, words, numWords, &rackTable)
+                    == 1) {
+        fprintf(stderr, "unscramble: rack table named \"%s\" is invalid\n",
+                table);
+        for (int i = 0; i < numWords; i++) {
+            free(words[i]);
+        }
+        free(words);
+        free_word_index(&index);
+        free_alphabet(&alphabet);
+        return rackTableErrorStatus;
+    }
+
+    // convert the letters to symbols, generating them if not provided, and
+    // keep the text to show the user
+    char* rack;
+    char* lettersText;
+    if (letters != NULL) {
+        rack = encode_word(&alphabet, letters);
+        lettersText = malloc(((int)strlen(letters) + 1) * sizeof(char));
+        strcpy(lettersText, letters);
+    } else {
+        rack = initialise_letters(&alphabet, table ? &rackTable : NULL);
+        lettersText = decode_word(&alphabet, rack);
+    }
+    // look up the stats of the letters, whether provided or generated,
+    // copying them before the table is unmapped
+    RackStats rackStats;
+    const RackStats* foundStats = NULL;
+    if (table != NULL) {
+        foundStats = lookup_rack_stats(&rackTable, &alphabet, rack);
+        if (foundStats != NULL) {
+            rackStats = *foundStats;
+            foundStats = &rackStats;
+        }
+        free_rack_table(&rackTable);
+    }
+
+    int gameStatus = start_game(&minLength, rack, lettersText, words,
+            &alphabet, foundStats, &index, topK);
+    free(rack);
+    free(lettersText);
+    free_alphabet(&alphabet);
+    return gameStatus;
 }